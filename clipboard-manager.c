@@ -1,9 +1,11 @@
 #include <windows.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <commctrl.h>
 #include <psapi.h>
 #include <time.h>
 #include <Uxtheme.h>
+#include "clipboard-metrics.h"
 #pragma comment(lib, "UxTheme.lib")
 #pragma comment(linker, "/subsystem:windows /ENTRY:mainCRTStartup")
 
@@ -38,9 +40,12 @@ void GetProcessInfo(DWORD processId, wchar_t* buffer, size_t bufferSize);
 void CopyProcessIdToClipboard(DWORD processId);
 void ClearClipboard(void);
 void EnableAutoRefresh(HWND hwnd, BOOL enable);
-void UpdatePreviewArea(UINT format);
+SIZE_T UpdatePreviewArea(UINT format);
 const wchar_t* GetFormatName(UINT format);
 void RepositionControls(HWND hwnd);
+SIZE_T GetClipboardDataSize(UINT format, HANDLE hData);
+void RecordRefreshMetrics(BOOL locked, DWORD processId, const wchar_t* processName, UINT formatCount,
+    SIZE_T payloadBytes, LARGE_INTEGER start, LARGE_INTEGER end);
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
     // Initialize common controls.
@@ -76,6 +81,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     );
     if (!hwnd) return 0;
 
+    // Serve refresh counters to local Prometheus scrapers, only when a port is configured.
+    const char* metricsPort = getenv("CLIPBOARD_METRICS_PORT");
+    if (metricsPort && *metricsPort) {
+        int port = atoi(metricsPort);
+        if (port <= 0 || port > 65535 || MetricsStartServer((unsigned short)port) != 0) {
+            wchar_t message[256];
+            _snwprintf_s(message, _countof(message), _TRUNCATE,
+                L"Metrics endpoint failed to start on port '%hs'.\r\n\r\nClick 'Check Clipboard' to begin...", metricsPort);
+            SetWindowTextW(statusText, message);
+        }
+    }
+
     ShowWindow(hwnd, nCmdShow);
     UpdateWindow(hwnd);
 
@@ -85,6 +102,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
+    MetricsStopServer();
     return (int)msg.wParam;
 }
 
@@ -394,8 +412,12 @@ const wchar_t* GetFormatName(UINT format) {
 }
 
 void UpdateClipboardStatus(HWND hwnd) {
+    LARGE_INTEGER refreshStart;
+    QueryPerformanceCounter(&refreshStart);
     HWND clipboardOwner = GetClipboardOwner();
     DWORD processId = 0;
+    UINT formatCount = CountClipboardFormats();  // Works even while another process holds the clipboard.
+    SIZE_T payloadBytes = 0;
     wchar_t statusBuffer[4096] = {0};
     wchar_t timeStr[64] = {0};
     time_t now;
@@ -407,7 +429,8 @@ void UpdateClipboardStatus(HWND hwnd) {
     _snwprintf_s(statusBuffer, _countof(statusBuffer), _TRUNCATE,
         L"Clipboard Status Check - %s\r\n----------------------------------------\r\n", timeStr);
 
-    if (!OpenClipboard(NULL)) {
+    BOOL locked = !OpenClipboard(NULL);
+    if (locked) {
         wcscat_s(statusBuffer, _countof(statusBuffer), L"Clipboard is locked!\r\n");
         if (clipboardOwner != NULL) {
             GetWindowThreadProcessId(clipboardOwner, &processId);
@@ -434,7 +457,7 @@ void UpdateClipboardStatus(HWND hwnd) {
         if (SendMessage(formatCombo, CB_GETCOUNT, 0, 0) > 0) {
             SendMessage(formatCombo, CB_SETCURSEL, 0, 0);
             UINT selectedFormat = (UINT)SendMessage(formatCombo, CB_GETITEMDATA, 0, 0);
-            UpdatePreviewArea(selectedFormat);
+            payloadBytes = UpdatePreviewArea(selectedFormat);
         } else {
             SetWindowTextW(previewText, L"No clipboard data available");
         }
@@ -443,6 +466,7 @@ void UpdateClipboardStatus(HWND hwnd) {
     SetWindowTextW(statusText, statusBuffer);
 
     // Update the ListView with process info.
+    wchar_t processName[MAX_PATH] = L"";
     ListView_DeleteAllItems(processList);
     if (processId != 0) {
         LVITEMW lvi = {0};
@@ -454,7 +478,6 @@ void UpdateClipboardStatus(HWND hwnd) {
         lvi.pszText = pidStr;
         ListView_InsertItem(processList, &lvi);
 
-        wchar_t processName[MAX_PATH] = L"";
         HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
         if (hProcess) {
             if (GetModuleBaseNameW(hProcess, NULL, processName, MAX_PATH)) {
@@ -471,6 +494,32 @@ void UpdateClipboardStatus(HWND hwnd) {
             ListView_SetItem(processList, &lvi);
         }
     }
+
+    LARGE_INTEGER refreshEnd;
+    QueryPerformanceCounter(&refreshEnd);
+    RecordRefreshMetrics(locked, processId, processName, formatCount, payloadBytes, refreshStart, refreshEnd);
+}
+
+// Returns the allocation size of clipboard data that was already fetched. GDI,
+// private and owner-display formats are not global memory and count as 0.
+SIZE_T GetClipboardDataSize(UINT format, HANDLE hData) {
+    if (hData == NULL || format == CF_BITMAP || format == CF_PALETTE || format == CF_ENHMETAFILE ||
+        format == CF_DSPBITMAP || format == CF_DSPENHMETAFILE || format == CF_OWNERDISPLAY ||
+        (format >= CF_GDIOBJFIRST && format <= CF_GDIOBJLAST) ||
+        (format >= CF_PRIVATEFIRST && format <= CF_PRIVATELAST))
+        return 0;
+    return GlobalSize(hData);
+}
+
+void RecordRefreshMetrics(BOOL locked, DWORD processId, const wchar_t* processName, UINT formatCount,
+    SIZE_T payloadBytes, LARGE_INTEGER start, LARGE_INTEGER end) {
+    char ownerName[METRICS_OWNER_NAME_SIZE] = "";
+    if (WideCharToMultiByte(CP_UTF8, 0, processName, -1, ownerName, sizeof(ownerName), NULL, NULL) == 0)
+        ownerName[0] = '\0';  // Never export a partially converted (invalid UTF-8) label.
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    unsigned long long elapsedMicros = (unsigned long long)(end.QuadPart - start.QuadPart) * 1000000 / frequency.QuadPart;
+    MetricsRecordRefresh(locked, processId, ownerName, formatCount, payloadBytes, elapsedMicros);
 }
 
 void CopyProcessIdToClipboard(DWORD processId) {
@@ -509,36 +558,46 @@ BOOL AttemptClipboardUnlock(HWND hwnd) {
     CloseClipboard();
     if (OpenClipboard(NULL)) {
         CloseClipboard();
+        MetricsRecordUnlockAttempt(TRUE);
         return TRUE;
     }
+    MetricsRecordUnlockAttempt(FALSE);
     return FALSE;
 }
 
 BOOL KillClipboardOwner(HWND hwnd) {
     HWND clipboardOwner = GetClipboardOwner();
-    if (clipboardOwner == NULL)
+    if (clipboardOwner == NULL) {
+        MetricsRecordKillAttempt(FALSE);
         return FALSE;
+    }
     DWORD processId;
     GetWindowThreadProcessId(clipboardOwner, &processId);
     HANDLE hProcess = OpenProcess(PROCESS_TERMINATE, FALSE, processId);
-    if (hProcess == NULL)
+    if (hProcess == NULL) {
+        MetricsRecordKillAttempt(FALSE);
         return FALSE;
+    }
     BOOL result = TerminateProcess(hProcess, 1);
     CloseHandle(hProcess);
+    MetricsRecordKillAttempt(result);
     return result;
 }
 
-void UpdatePreviewArea(UINT format) {
+// Returns the size of the previewed data so refreshes can report it without
+// fetching (and forcing the owner to render) any other format.
+SIZE_T UpdatePreviewArea(UINT format) {
     if (!OpenClipboard(NULL)) {
         SetWindowTextW(previewText, L"Cannot access clipboard");
-        return;
+        return 0;
     }
     HANDLE hData = GetClipboardData(format);
     if (hData == NULL) {
         SetWindowTextW(previewText, L"No data available in this format");
         CloseClipboard();
-        return;
+        return 0;
     }
+    SIZE_T dataSize = GetClipboardDataSize(format, hData);
     wchar_t previewBuffer[MAX_PREVIEW_SIZE] = {0};
     switch (format) {
         case CF_TEXT:
@@ -597,6 +656,7 @@ void UpdatePreviewArea(UINT format) {
     }
     SetWindowTextW(previewText, previewBuffer);
     CloseClipboard();
+    return dataSize;
 }
 
 void RepositionControls(HWND hwnd) {
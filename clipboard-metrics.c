@@ -0,0 +1,443 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L  // poll, nanosleep and clock_gettime under -std=c11.
+#endif
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET metrics_socket_t;
+#define METRICS_INVALID_SOCKET INVALID_SOCKET
+#define CloseMetricsSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int metrics_socket_t;
+#define METRICS_INVALID_SOCKET (-1)
+#define CloseMetricsSocket close
+#endif
+// A scraper that hangs up early must not raise SIGPIPE and kill the application.
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "clipboard-metrics.h"
+
+// Total time a client gets to send its request headers, however it paces them.
+#define REQUEST_TIMEOUT_MS    2000
+// Pause before retrying accept() when the process is out of descriptors/buffers.
+#define ACCEPT_BACKOFF_MS     100
+
+// Counters are plain 64-bit integers touched only through these macros. Each
+// value is read atomically, but a scrape is not a snapshot across counters.
+#ifdef _WIN32
+#define METRIC_ADD(p, v)   InterlockedExchangeAdd64((volatile LONG64*)(p), (LONG64)(v))
+#define METRIC_STORE(p, v) InterlockedExchange64((volatile LONG64*)(p), (LONG64)(v))
+#define METRIC_LOAD(p)     InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#else
+#define METRIC_ADD(p, v)   __atomic_fetch_add((p), (long long)(v), __ATOMIC_SEQ_CST)
+#define METRIC_STORE(p, v) __atomic_store_n((p), (long long)(v), __ATOMIC_SEQ_CST)
+#define METRIC_LOAD(p)     __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#endif
+
+// Refresh latency bucket upper bounds, in microseconds (+Inf is implicit).
+static const long long latencyBucketsMicros[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000
+};
+#define LATENCY_BUCKET_COUNT (sizeof(latencyBucketsMicros) / sizeof(latencyBucketsMicros[0]))
+
+static volatile long long refreshesTotal;
+static volatile long long lockedObservations;
+static volatile long long availableObservations;
+static volatile long long clipboardLocked;
+static volatile long long ownerPid;
+static volatile long long formatCount;
+static volatile long long payloadBytes;
+static volatile long long lastRefreshTimestamp;
+static volatile long long unlockSuccesses, unlockFailures;
+static volatile long long killSuccesses, killFailures;
+static volatile long long latencyBuckets[LATENCY_BUCKET_COUNT + 1]; // Non-cumulative; last is +Inf.
+static volatile long long latencySumMicros;
+
+// The owner name is not a single word, so it is copied in and out under a lock.
+static char ownerName[METRICS_OWNER_NAME_SIZE];
+#ifdef _WIN32
+static SRWLOCK ownerNameLock = SRWLOCK_INIT;
+#define LockOwnerName()   AcquireSRWLockExclusive(&ownerNameLock)
+#define UnlockOwnerName() ReleaseSRWLockExclusive(&ownerNameLock)
+#else
+static pthread_mutex_t ownerNameLock = PTHREAD_MUTEX_INITIALIZER;
+#define LockOwnerName()   pthread_mutex_lock(&ownerNameLock)
+#define UnlockOwnerName() pthread_mutex_unlock(&ownerNameLock)
+#endif
+
+static metrics_socket_t listenSocket = METRICS_INVALID_SOCKET;
+static volatile long long stopRequested;
+#ifdef _WIN32
+static HANDLE serverThread = NULL;
+#else
+static pthread_t serverThread;
+static int serverThreadStarted = 0;
+#endif
+
+void MetricsRecordRefresh(int locked, unsigned long pid, const char* name,
+    unsigned int formats, unsigned long long bytes, unsigned long long elapsedMicros) {
+    METRIC_ADD(&refreshesTotal, 1);
+    METRIC_ADD(locked ? &lockedObservations : &availableObservations, 1);
+    METRIC_STORE(&clipboardLocked, locked ? 1 : 0);
+    METRIC_STORE(&ownerPid, pid);
+    METRIC_STORE(&formatCount, formats);
+    METRIC_STORE(&payloadBytes, bytes);
+    METRIC_STORE(&lastRefreshTimestamp, time(NULL));
+
+    size_t bucket = 0;
+    while (bucket < LATENCY_BUCKET_COUNT && (long long)elapsedMicros > latencyBucketsMicros[bucket])
+        bucket++;
+    METRIC_ADD(&latencyBuckets[bucket], 1);
+    METRIC_ADD(&latencySumMicros, elapsedMicros);
+
+    LockOwnerName();
+    strncpy(ownerName, name ? name : "", sizeof(ownerName) - 1);
+    ownerName[sizeof(ownerName) - 1] = '\0';
+    UnlockOwnerName();
+}
+
+void MetricsRecordUnlockAttempt(int succeeded) {
+    METRIC_ADD(succeeded ? &unlockSuccesses : &unlockFailures, 1);
+}
+
+void MetricsRecordKillAttempt(int succeeded) {
+    METRIC_ADD(succeeded ? &killSuccesses : &killFailures, 1);
+}
+
+static void ReadOwnerName(char* buffer, size_t bufferSize) {
+    LockOwnerName();
+    strncpy(buffer, ownerName, bufferSize - 1);
+    UnlockOwnerName();
+    buffer[bufferSize - 1] = '\0';
+}
+
+// Appends formatted text, tracking the offset and clamping at the buffer end.
+static void Append(char* buffer, size_t bufferSize, size_t* offset, const char* fmt, ...) {
+    if (*offset >= bufferSize - 1)
+        return;
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(buffer + *offset, bufferSize - *offset, fmt, args);
+    va_end(args);
+    if (written < 0)
+        return;
+    *offset += (size_t)written < bufferSize - *offset ? (size_t)written : bufferSize - *offset - 1;
+}
+
+static void EscapeLabelValue(const char* value, char* escaped, size_t escapedSize) {
+    size_t out = 0;
+    for (; *value && out + 2 < escapedSize; value++) {
+        if (*value == '\\' || *value == '"') {
+            escaped[out++] = '\\';
+            escaped[out++] = *value;
+        } else if (*value == '\n') {
+            escaped[out++] = '\\';
+            escaped[out++] = 'n';
+        } else {
+            escaped[out++] = *value;
+        }
+    }
+    escaped[out] = '\0';
+}
+
+size_t MetricsFormat(char* buffer, size_t bufferSize) {
+    size_t offset = 0;
+    char name[METRICS_OWNER_NAME_SIZE];
+    char escapedName[METRICS_OWNER_NAME_SIZE * 2];
+    if (bufferSize == 0)
+        return 0;
+    buffer[0] = '\0';
+    ReadOwnerName(name, sizeof(name));
+    EscapeLabelValue(name, escapedName, sizeof(escapedName));
+
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_refreshes_total Clipboard status refreshes performed.\n"
+        "# TYPE clipboard_refreshes_total counter\n"
+        "clipboard_refreshes_total %lld\n", METRIC_LOAD(&refreshesTotal));
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_observations_total Refreshes by observed clipboard state.\n"
+        "# TYPE clipboard_observations_total counter\n"
+        "clipboard_observations_total{state=\"locked\"} %lld\n"
+        "clipboard_observations_total{state=\"available\"} %lld\n",
+        METRIC_LOAD(&lockedObservations), METRIC_LOAD(&availableObservations));
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_locked Whether the clipboard was locked at the last refresh.\n"
+        "# TYPE clipboard_locked gauge\n"
+        "clipboard_locked %lld\n", METRIC_LOAD(&clipboardLocked));
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_owner_pid Process ID holding the clipboard lock at the last refresh (0 if none).\n"
+        "# TYPE clipboard_owner_pid gauge\n"
+        "clipboard_owner_pid %lld\n", METRIC_LOAD(&ownerPid));
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_owner_info Name of the process holding the clipboard lock at the last refresh.\n"
+        "# TYPE clipboard_owner_info gauge\n");
+    if (escapedName[0] != '\0')
+        Append(buffer, bufferSize, &offset, "clipboard_owner_info{name=\"%s\"} 1\n", escapedName);
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_formats Number of formats on the clipboard at the last refresh.\n"
+        "# TYPE clipboard_formats gauge\n"
+        "clipboard_formats %lld\n", METRIC_LOAD(&formatCount));
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_payload_bytes Size of the previewed clipboard format at the last refresh.\n"
+        "# TYPE clipboard_payload_bytes gauge\n"
+        "clipboard_payload_bytes %lld\n", METRIC_LOAD(&payloadBytes));
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_last_refresh_timestamp_seconds Unix time of the last refresh.\n"
+        "# TYPE clipboard_last_refresh_timestamp_seconds gauge\n"
+        "clipboard_last_refresh_timestamp_seconds %lld\n", METRIC_LOAD(&lastRefreshTimestamp));
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_unlock_attempts_total Force unlock attempts by outcome.\n"
+        "# TYPE clipboard_unlock_attempts_total counter\n"
+        "clipboard_unlock_attempts_total{result=\"success\"} %lld\n"
+        "clipboard_unlock_attempts_total{result=\"failure\"} %lld\n",
+        METRIC_LOAD(&unlockSuccesses), METRIC_LOAD(&unlockFailures));
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_kill_attempts_total Owner process termination attempts by outcome.\n"
+        "# TYPE clipboard_kill_attempts_total counter\n"
+        "clipboard_kill_attempts_total{result=\"success\"} %lld\n"
+        "clipboard_kill_attempts_total{result=\"failure\"} %lld\n",
+        METRIC_LOAD(&killSuccesses), METRIC_LOAD(&killFailures));
+
+    Append(buffer, bufferSize, &offset,
+        "# HELP clipboard_refresh_duration_seconds Time spent in a clipboard status refresh.\n"
+        "# TYPE clipboard_refresh_duration_seconds histogram\n");
+    long long cumulative = 0;
+    for (size_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        cumulative += METRIC_LOAD(&latencyBuckets[i]);
+        Append(buffer, bufferSize, &offset, "clipboard_refresh_duration_seconds_bucket{le=\"%g\"} %lld\n",
+            latencyBucketsMicros[i] / 1e6, cumulative);
+    }
+    cumulative += METRIC_LOAD(&latencyBuckets[LATENCY_BUCKET_COUNT]);
+    Append(buffer, bufferSize, &offset,
+        "clipboard_refresh_duration_seconds_bucket{le=\"+Inf\"} %lld\n"
+        "clipboard_refresh_duration_seconds_sum %.6f\n"
+        "clipboard_refresh_duration_seconds_count %lld\n",
+        cumulative, METRIC_LOAD(&latencySumMicros) / 1e6, cumulative);
+    return offset;
+}
+
+static long long MonotonicMillis(void) {
+#ifdef _WIN32
+    return (long long)GetTickCount64();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
+
+static void SleepMillis(int milliseconds) {
+#ifdef _WIN32
+    Sleep((DWORD)milliseconds);
+#else
+    struct timespec delay = { milliseconds / 1000, (long)(milliseconds % 1000) * 1000000 };
+    nanosleep(&delay, NULL);
+#endif
+}
+
+// Returns nonzero once the socket has data (or EOF) within the timeout.
+static int WaitReadable(metrics_socket_t client, int timeoutMillis) {
+#ifdef _WIN32
+    WSAPOLLFD entry = { client, POLLRDNORM, 0 };
+    return WSAPoll(&entry, 1, timeoutMillis) > 0;
+#else
+    struct pollfd entry = { client, POLLIN, 0 };
+    return poll(&entry, 1, timeoutMillis) > 0;
+#endif
+}
+
+static void SendAll(metrics_socket_t client, const char* data, size_t length) {
+    while (length > 0) {
+        int sent = send(client, data, (int)length, SEND_FLAGS);
+        if (sent <= 0)
+            return;
+        data += sent;
+        length -= (size_t)sent;
+    }
+}
+
+static int StartsWithIgnoreCase(const char* text, const char* prefix) {
+    for (; *prefix; text++, prefix++) {
+        if (tolower((unsigned char)*text) != tolower((unsigned char)*prefix))
+            return 0;
+    }
+    return 1;
+}
+
+// Accepts only Host headers naming the loopback address, so a web page that
+// rebinds its own domain to 127.0.0.1 cannot read the owner process details.
+static int IsLoopbackHost(const char* request) {
+    const char* line = strstr(request, "\r\n");
+    while (line && line[2] != '\r') {
+        line += 2;
+        if (StartsWithIgnoreCase(line, "Host:")) {
+            const char* host = line + 5;
+            while (*host == ' ' || *host == '\t')
+                host++;
+            size_t length = strcspn(host, ":\r");
+            return (length == 9 && StartsWithIgnoreCase(host, "127.0.0.1")) ||
+                (length == 9 && StartsWithIgnoreCase(host, "localhost"));
+        }
+        line = strstr(line, "\r\n");
+    }
+    return 0;
+}
+
+static void SendStatus(metrics_socket_t client, const char* status) {
+    char response[128];
+    int length = snprintf(response, sizeof(response),
+        "HTTP/1.0 %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", status);
+    SendAll(client, response, (size_t)length);
+}
+
+// Answers a single scrape. Requests without a loopback Host header get a 403;
+// anything other than GET /metrics (or /) gets a 404.
+static void ServeClient(metrics_socket_t client) {
+    static char body[METRICS_RESPONSE_SIZE];
+    char request[2048] = {0};
+    char header[256];
+    size_t received = 0;
+    long long deadline = MonotonicMillis() + REQUEST_TIMEOUT_MS;
+    while (received < sizeof(request) - 1 && !strstr(request, "\r\n\r\n")) {
+        long long remaining = deadline - MonotonicMillis();
+        if (remaining <= 0 || !WaitReadable(client, (int)remaining))
+            return;  // Too slow; a trickling client must not hold the server thread.
+        int chunk = recv(client, request + received, (int)(sizeof(request) - 1 - received), 0);
+        if (chunk <= 0)
+            return;
+        received += (size_t)chunk;
+    }
+
+    if (!IsLoopbackHost(request)) {
+        SendStatus(client, "403 Forbidden");
+    } else if (strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET / ", 6) == 0) {
+        size_t length = MetricsFormat(body, sizeof(body));
+        int headerLength = snprintf(header, sizeof(header),
+            "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+            "Content-Length: %lu\r\nConnection: close\r\n\r\n", (unsigned long)length);
+        SendAll(client, header, (size_t)headerLength);
+        SendAll(client, body, length);
+    } else {
+        SendStatus(client, "404 Not Found");
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI ServerLoop(LPVOID param) {
+#else
+static void* ServerLoop(void* param) {
+#endif
+    (void)param;
+    for (;;) {
+        metrics_socket_t client = accept(listenSocket, NULL, NULL);
+        if (client == METRICS_INVALID_SOCKET) {
+            if (METRIC_LOAD(&stopRequested))
+                break;
+            // Only a dead listening socket ends the loop; transient failures
+            // (a client resetting while queued, EINTR, descriptor exhaustion) are retried.
+#ifdef _WIN32
+            int error = WSAGetLastError();
+            if (error == WSAENOTSOCK || error == WSAEINVAL)
+                break;
+            if (error == WSAEMFILE || error == WSAENOBUFS)
+                SleepMillis(ACCEPT_BACKOFF_MS);
+#else
+            int error = errno;
+            if (error == EBADF || error == EINVAL || error == ENOTSOCK)
+                break;
+            if (error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM)
+                SleepMillis(ACCEPT_BACKOFF_MS);
+#endif
+            continue;
+        }
+        ServeClient(client);
+        CloseMetricsSocket(client);
+    }
+    return 0;
+}
+
+int MetricsStartServer(unsigned short port) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+        return -1;
+#endif
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    METRIC_STORE(&stopRequested, 0);
+    listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSocket == METRICS_INVALID_SOCKET)
+        goto fail;
+#ifndef _WIN32
+    // Allow an immediate restart while old connections sit in TIME_WAIT. Not
+    // set on Windows, where SO_REUSEADDR would let another process steal the port.
+    int reuse = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+    if (bind(listenSocket, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenSocket, 4) != 0)
+        goto fail;
+#ifdef _WIN32
+    serverThread = CreateThread(NULL, 0, ServerLoop, NULL, 0, NULL);
+    if (serverThread == NULL)
+        goto fail;
+#else
+    if (pthread_create(&serverThread, NULL, ServerLoop, NULL) != 0)
+        goto fail;
+    serverThreadStarted = 1;
+#endif
+    return 0;
+
+fail:
+    if (listenSocket != METRICS_INVALID_SOCKET) {
+        CloseMetricsSocket(listenSocket);
+        listenSocket = METRICS_INVALID_SOCKET;
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return -1;
+}
+
+void MetricsStopServer(void) {
+    if (listenSocket == METRICS_INVALID_SOCKET)
+        return;
+    METRIC_STORE(&stopRequested, 1);
+#ifdef _WIN32
+    closesocket(listenSocket);
+    if (serverThread) {
+        WaitForSingleObject(serverThread, 5000);
+        CloseHandle(serverThread);
+        serverThread = NULL;
+    }
+    WSACleanup();
+#else
+    shutdown(listenSocket, SHUT_RDWR);  // Wakes the blocked accept().
+    close(listenSocket);
+    if (serverThreadStarted) {
+        pthread_join(serverThread, NULL);
+        serverThreadStarted = 0;
+    }
+#endif
+    listenSocket = METRICS_INVALID_SOCKET;
+}
@@ -0,0 +1,26 @@
+#ifndef CLIPBOARD_METRICS_H
+#define CLIPBOARD_METRICS_H
+
+#include <stddef.h>
+
+// Room for a MAX_PATH (260) UTF-16 process name converted to UTF-8.
+#define METRICS_OWNER_NAME_SIZE  (260 * 3)
+#define METRICS_RESPONSE_SIZE    8192
+
+// Recording functions are called from the refresh path and only update
+// pre-aggregated counters; at most they wait for a scrape to copy the owner name.
+void MetricsRecordRefresh(int locked, unsigned long ownerPid, const char* ownerName,
+    unsigned int formatCount, unsigned long long payloadBytes, unsigned long long elapsedMicros);
+void MetricsRecordUnlockAttempt(int succeeded);
+void MetricsRecordKillAttempt(int succeeded);
+
+// Renders the current counters in Prometheus text exposition format.
+// Returns the number of bytes written (excluding the terminator).
+size_t MetricsFormat(char* buffer, size_t bufferSize);
+
+// Serves MetricsFormat() output over HTTP on 127.0.0.1 from a background
+// thread. Returns 0 on success, -1 if the socket or thread could not be set up.
+int MetricsStartServer(unsigned short port);
+void MetricsStopServer(void);
+
+#endif // CLIPBOARD_METRICS_H
@@ -1,5 +1,5 @@
 if not exist clipboard-manager.exe (
-    zig cc clipboard-manager.c -o clipboard-manager.exe -luser32 -lcomctl32 -luxtheme -lgdi32 -Wl,/subsystem:windows -lpsapi -Ofast
+    zig cc clipboard-manager.c clipboard-metrics.c -o clipboard-manager.exe -luser32 -lcomctl32 -luxtheme -lgdi32 -Wl,/subsystem:windows -lpsapi -lws2_32 -Ofast
 )
 
 start "" clipboard-manager.exe
@@ -1,5 +1,5 @@
 if (-not (Test-Path clipboard-manager.exe)) {
-    & zig cc "${PSScriptRoot}/clipboard-manager.c" -o "${PSScriptRoot}/clipboard-manager.exe" -luser32 -lcomctl32 -luxtheme -lgdi32 "-Wl,/subsystem:windows" -lpsapi -Ofast
+    & zig cc "${PSScriptRoot}/clipboard-manager.c" "${PSScriptRoot}/clipboard-metrics.c" -o "${PSScriptRoot}/clipboard-manager.exe" -luser32 -lcomctl32 -luxtheme -lgdi32 "-Wl,/subsystem:windows" -lpsapi -lws2_32 -Ofast
 }
 
 Start-Process -FilePath "${PSScriptRoot}/clipboard-manager.exe"
@@ -0,0 +1,171 @@
+// Simulated clipboard backend for the metrics endpoint. Feeds known refreshes
+// and unlock/kill outcomes into clipboard-metrics.c, scrapes the server with
+// curl, and checks the exported values. Builds on Linux (POSIX sockets):
+//
+//   gcc -std=c11 -Wall -Wextra -pedantic tests/metrics-sim.c clipboard-metrics.c -I. -pthread -o metrics-sim
+//   ./metrics-sim [port]
+#define _POSIX_C_SOURCE 200809L
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "clipboard-metrics.h"
+
+#define DEFAULT_TEST_PORT 19478
+
+static int failures = 0;
+
+// Runs a command and captures its standard output.
+static void Capture(const char* command, char* output, size_t outputSize) {
+    size_t length = 0;
+    FILE* pipe = popen(command, "r");
+    output[0] = '\0';
+    if (!pipe)
+        return;
+    while (length < outputSize - 1) {
+        size_t chunk = fread(output + length, 1, outputSize - 1 - length, pipe);
+        if (chunk == 0)
+            break;
+        length += chunk;
+    }
+    output[length] = '\0';
+    pclose(pipe);
+}
+
+// Connects and sends one request byte every 500 ms for 6 s, which would keep
+// a per-recv timeout from ever firing.
+static void* TrickleClient(void* param) {
+    struct sockaddr_in addr;
+    struct timespec pause = { 0, 500000000 };
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)*(int*)param);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(client, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        for (int i = 0; i < 12; i++) {
+            if (send(client, "G", 1, MSG_NOSIGNAL) != 1)
+                break;
+            nanosleep(&pause, NULL);
+        }
+    }
+    close(client);
+    return NULL;
+}
+
+static void ExpectLine(const char* body, const char* line) {
+    char needle[256];
+    snprintf(needle, sizeof(needle), "\n%s\n", line);
+    if (!strstr(body, needle)) {
+        printf("FAIL: missing \"%s\"\n", line);
+        failures++;
+    }
+}
+
+static void ExpectAbsent(const char* body, const char* text) {
+    if (strstr(body, text)) {
+        printf("FAIL: unexpected \"%s\"\n", text);
+        failures++;
+    }
+}
+
+static void ExpectEqual(const char* what, const char* actual, const char* expected) {
+    if (strcmp(actual, expected) != 0) {
+        printf("FAIL: %s: got \"%s\", expected \"%s\"\n", what, actual, expected);
+        failures++;
+    }
+}
+
+int main(int argc, char** argv) {
+    static char body[METRICS_RESPONSE_SIZE * 2];
+    char command[256], status[32];
+    int port = argc > 1 ? atoi(argv[1]) : DEFAULT_TEST_PORT;
+
+    if (MetricsStartServer((unsigned short)port) != 0) {
+        printf("FAIL: could not start metrics server on port %d\n", port);
+        return 1;
+    }
+
+    // Nothing refreshed yet: no owner series should be exported.
+    snprintf(command, sizeof(command), "curl -s http://127.0.0.1:%d/metrics", port);
+    Capture(command, body, sizeof(body));
+    ExpectLine(body, "clipboard_refreshes_total 0");
+    ExpectAbsent(body, "clipboard_owner_info{");
+
+    // Ten refreshes: every fifth one finds the clipboard locked by a process
+    // whose name needs label escaping. The last refresh is locked; its formats
+    // are still counted but nothing could be previewed.
+    for (int i = 1; i <= 10; i++) {
+        int locked = i % 5 == 0;
+        MetricsRecordRefresh(locked, locked ? 4242 : 0, locked ? "we\"ird\\app.exe" : "",
+            locked ? 4 : 3, locked ? 0 : 2048, (unsigned long long)i * 1000);
+    }
+    MetricsRecordUnlockAttempt(1);
+    MetricsRecordUnlockAttempt(0);
+    MetricsRecordUnlockAttempt(0);
+    MetricsRecordKillAttempt(0);
+
+    Capture(command, body, sizeof(body));
+    ExpectLine(body, "clipboard_refreshes_total 10");
+    ExpectLine(body, "clipboard_observations_total{state=\"locked\"} 2");
+    ExpectLine(body, "clipboard_observations_total{state=\"available\"} 8");
+    ExpectLine(body, "clipboard_locked 1");
+    ExpectLine(body, "clipboard_owner_pid 4242");
+    ExpectLine(body, "clipboard_owner_info{name=\"we\\\"ird\\\\app.exe\"} 1");
+    ExpectLine(body, "clipboard_formats 4");
+    ExpectLine(body, "clipboard_payload_bytes 0");
+    ExpectLine(body, "clipboard_unlock_attempts_total{result=\"success\"} 1");
+    ExpectLine(body, "clipboard_unlock_attempts_total{result=\"failure\"} 2");
+    ExpectLine(body, "clipboard_kill_attempts_total{result=\"success\"} 0");
+    ExpectLine(body, "clipboard_kill_attempts_total{result=\"failure\"} 1");
+    ExpectLine(body, "clipboard_refresh_duration_seconds_bucket{le=\"0.001\"} 1");
+    ExpectLine(body, "clipboard_refresh_duration_seconds_bucket{le=\"0.005\"} 5");
+    ExpectLine(body, "clipboard_refresh_duration_seconds_bucket{le=\"0.01\"} 10");
+    ExpectLine(body, "clipboard_refresh_duration_seconds_bucket{le=\"+Inf\"} 10");
+    ExpectLine(body, "clipboard_refresh_duration_seconds_sum 0.055000");
+    ExpectLine(body, "clipboard_refresh_duration_seconds_count 10");
+
+    // An available refresh with no owner drops the owner series again.
+    MetricsRecordRefresh(0, 0, "", 2, 512, 100);
+    Capture(command, body, sizeof(body));
+    ExpectLine(body, "clipboard_owner_pid 0");
+    ExpectLine(body, "clipboard_payload_bytes 512");
+    ExpectAbsent(body, "clipboard_owner_info{");
+
+    snprintf(command, sizeof(command), "curl -s -o /dev/null -w '%%{http_code}' http://127.0.0.1:%d/other", port);
+    Capture(command, status, sizeof(status));
+    ExpectEqual("unknown path", status, "404");
+
+    snprintf(command, sizeof(command), "curl -s -o /dev/null -w '%%{http_code}' http://localhost:%d/metrics", port);
+    Capture(command, status, sizeof(status));
+    ExpectEqual("localhost host", status, "200");
+
+    snprintf(command, sizeof(command),
+        "curl -s -o /dev/null -w '%%{http_code}' -H 'Host: attacker.example' http://127.0.0.1:%d/metrics", port);
+    Capture(command, status, sizeof(status));
+    ExpectEqual("foreign host", status, "403");
+
+    // A client trickling its request must be dropped after the total request
+    // timeout, so a concurrent scrape still completes well within its own limit.
+    pthread_t trickle;
+    pthread_create(&trickle, NULL, TrickleClient, &port);
+    sleep(1);
+    snprintf(command, sizeof(command),
+        "curl -s -o /dev/null -w '%%{http_code}' --max-time 4 http://127.0.0.1:%d/metrics", port);
+    Capture(command, status, sizeof(status));
+    ExpectEqual("scrape behind trickling client", status, "200");
+    pthread_join(trickle, NULL);
+
+    MetricsStopServer();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("All metrics checks passed\n");
+    return 0;
+}